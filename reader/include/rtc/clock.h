@@ -0,0 +1,71 @@
+#ifndef RTC_CLOCK_H
+#define RTC_CLOCK_H
+/*
+ * Ruler Trace Container
+ * Copyright (C) 2020-2021  Jochem Rutgers
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef __cplusplus
+
+#include "rtc/stream.h"
+#include "rtc/util.h"
+
+#include <string>
+
+namespace rtc {
+
+	/*! \brief Time in seconds, as decoded from a clock frame. */
+	typedef double Time;
+
+	/*!
+	 * \brief Decoder for the frames of a clock stream.
+	 *
+	 * A clock stream has its \c clock field set to \c true.  See the
+	 * Timestamp section of doc/format.md.
+	 */
+	class Clock {
+	public:
+		explicit Clock(Stream const& stream);
+
+		static bool isClock(Stream const& stream);
+
+		Stream const& stream() const;
+		bool isDelta() const;
+		std::string const& delta() const;
+
+		Time decode(View payload) const;
+
+	private:
+		Stream const* m_stream;
+		std::string m_delta;
+		double m_gain;
+		double m_offset;
+	};
+
+	/*!
+	 * \brief Decode a single number of one of the default formats.
+	 *
+	 * Supported are the \c u?int, \c float, \c u?leb128 and \c timespec
+	 * formats.  Gain and offset are not applied.
+	 *
+	 * \exception FormatError when the format is unknown or \p payload is too short
+	 */
+	double decodeNumber(std::string const& format, View payload);
+
+} // namespace
+
+#endif // __cplusplus
+#endif // RTC_CLOCK_H
@@ -21,6 +21,7 @@
 #ifdef __cplusplus
 
 #include "rtc_writer.h"
+#include "rtc/clock.h"
 #include "rtc/stream.h"
 #include "rtc/util.h"
 
@@ -72,6 +73,7 @@ namespace rtc {
 		Frame const& prevMeta();
 		Frame const& nextFrame();
 		Frame const& nextFrame(Stream const& stream);
+		Frame const& seekTime(Stream const& clock, Time t, bool interpolate = true);
 		Cursor& operator++();
 
 		Frame const& currentFrame() const;
@@ -85,6 +87,7 @@ namespace rtc {
 		crc_t currentUnitCrc();
 
 		Stream const* stream(Stream::Id id, bool autoLoadMeta = true);
+		Stream const* stream(std::string const& name) const;
 		Offset index(Stream::Id id);
 
 		template <typename F>
@@ -102,12 +105,15 @@ namespace rtc {
 		}
 
 		std::vector<unsigned char> fullFrame();
+		View payload(Frame const& frame);
 	protected:
 		void seekUnsafe(Offset offset);
 		Frame const& findMarker(bool forward);
 		Frame const& parseFrame(bool autoLoadMeta = true);
 		void loadMeta();
 		void loadIndex();
+		Offset skipUnits(Stream::Id id, Offset& scanUntil);
+		Offset indexEntry(Offset indexFrame, Stream::Id id);
 		Scope stashPos();
 	private:
 		Reader* m_reader;
@@ -121,6 +127,7 @@ namespace rtc {
 		std::map<Stream::Id,std::unique_ptr<Stream>> m_streams;
 		std::map<Stream::Id,Offset> m_index;
 		uint64_t m_IndexCount;
+		std::vector<unsigned char> m_payload;
 
 		friend class Reader;
 	};
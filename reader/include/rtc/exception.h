@@ -156,6 +156,12 @@ namespace rtc {
 		virtual ~FormatError() override = default;
 	};
 
+	class EofError : public FormatError {
+	public:
+		EofError() : FormatError("End of file") {}
+		virtual ~EofError() override = default;
+	};
+
 #undef RTC_EXCEPTION_CTOR
 
 } // namespace
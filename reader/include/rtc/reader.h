@@ -33,10 +33,21 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <utility>
 
 namespace rtc {
 
+	/*!
+	 * \brief Random access to a RTC file.
+	 *
+	 * Reads do not depend on a file position, so one Reader (and its cache)
+	 * can be shared by Cursors in multiple threads. Opening and closing the
+	 * file, and changing the cache configuration, are not thread-safe.
+	 */
 	class Reader {
 	public:
 		enum {
@@ -46,18 +57,43 @@ namespace rtc {
 			MaxPayload = MarkerBlock,
 		};
 
+		enum Mode {
+			/*! \brief Read the file using stdio. */
+			ModeStdio = 0,
+			/*! \brief Map the full file in memory. Only supported for POSIX. */
+			ModeMap = 1,
+			/*! \brief Hint that the mapping is read sequentially. */
+			ModeSequential = 2,
+			/*! \brief Prefault the full mapping. */
+			ModePopulate = 4,
+			/*! \brief Hint that the mapping should use huge pages. */
+			ModeHugePages = 8,
+		};
+
+		enum {
+			/*! \brief Default cache block size, which equals the writer's default \c unit. */
+			DefaultCacheBlockSize = 1u << 17u,
+			/*! \brief Default number of cached blocks. */
+			DefaultCacheBlocks = 16,
+		};
+
+		struct CacheStats {
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+		};
+
 		Reader();
 
-		template <typename Arg>
-		explicit Reader(Arg&& arg)
+		template <typename... Args>
+		explicit Reader(Args&&... args)
 			: Reader()
 		{
-			open(std::forward<Arg>(arg));
+			open(std::forward<Args>(args)...);
 		}
 
 		~Reader();
 
-		void open(char const* filename);
+		void open(char const* filename, int mode = ModeStdio);
 		void open(FILE* f);
 #ifdef _POSIX_C_SOURCE
 		void open(int fd);
@@ -65,22 +101,51 @@ namespace rtc {
 		void close();
 
 		bool isOpen() const;
-		Offset pos();
+		bool isMapped() const;
+		Offset size() const;
 
-		void seek(Offset offset, int whence);
 		size_t read(Offset offset, void* dst, size_t len);
+		View view(Offset offset, size_t len) const;
 		size_t readInt(Offset offset, uint64_t& dst);
-		static size_t decodeInt(unsigned char* buffer, size_t len, uint64_t& dst);
-		bool eof() const;
+		static size_t decodeInt(unsigned char const* buffer, size_t len, uint64_t& dst);
+
+		void setCache(size_t blocks, size_t blockSize = DefaultCacheBlockSize);
+		void flushCache();
+		CacheStats cacheStats() const;
 
 		Cursor cursor();
 
 		crc_t crc(Offset start, Offset end);
 	protected:
 		FILE* file() const;
+		void map(int mode);
+		void unmap();
+		size_t readFile(Offset offset, void* dst, size_t len);
+		size_t readCached(Offset offset, void* dst, size_t len);
 	private:
 		FILE* m_file = nullptr;
-		Offset m_pos = 0;
+		int m_fd = -1;
+		bool m_mapped = false;
+		unsigned char const* m_map = nullptr;
+		size_t m_mapSize = 0;
+
+		struct CacheBlock {
+			Offset offset;
+			size_t size;
+			std::unique_ptr<unsigned char[]> data;
+		};
+
+		// Most recently used block at the front.
+		std::list<CacheBlock> m_cache;
+		std::map<Offset,std::list<CacheBlock>::iterator> m_cacheIndex;
+		size_t m_cacheBlocks = DefaultCacheBlocks;
+		size_t m_cacheBlockSize = DefaultCacheBlockSize;
+		CacheStats m_cacheStats;
+		mutable std::mutex m_cacheLock;
+#ifndef _POSIX_C_SOURCE
+		// Protects the FILE position, as there is no pread().
+		mutable std::mutex m_fileLock;
+#endif
 	};
 } // namespace
 
@@ -0,0 +1,105 @@
+#ifndef RTC_SCAN_H
+#define RTC_SCAN_H
+/*
+ * Ruler Trace Container
+ * Copyright (C) 2020-2021  Jochem Rutgers
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef __cplusplus
+
+#include "rtc/reader.h"
+
+#include <functional>
+#include <vector>
+
+namespace rtc {
+
+	/*!
+	 * \brief Determine the size of the partitions for #scan().
+	 *
+	 * This is the \c Unit size of the file, or the file size when the file
+	 * has no usable Index.
+	 */
+	Offset scanPartitionSize(Reader& reader);
+
+	/*!
+	 * \brief Call \p f(i, worker) for all \c i in <tt>[0,count)</tt> using a pool of threads.
+	 *
+	 * Threads take the next index from a shared counter, so a slow item does
+	 * not hold back the others.  \c worker identifies the calling thread, in
+	 * the range <tt>[0,threads)</tt>.  The first exception thrown by \p f
+	 * stops the pool and is rethrown.
+	 *
+	 * \param threads the number of threads, or 0 for the hardware concurrency
+	 */
+	void parallelFor(size_t count, std::function<void(size_t,unsigned)> const& f, unsigned threads = 0);
+
+	/*!
+	 * \brief Return the number of threads #parallelFor() will use.
+	 */
+	unsigned parallelThreads(size_t count, unsigned threads = 0);
+
+	/*!
+	 * \brief Scan all frames of the file in parallel.
+	 *
+	 * The file is partitioned at the Marker boundaries.  As every Unit starts
+	 * with a Marker, Index and Meta, the Units are processed independently,
+	 * each by a Cursor of the worker thread.  \p f is called as
+	 * <tt>f(Cursor&, Frame const&, Result&)</tt> for every frame that starts
+	 * within the Unit, in file order.  Frames that are split over multiple
+	 * Units are passed per part, like Cursor::nextFrame() does.
+	 *
+	 * \return one \c Result per Unit, in file order
+	 */
+	template <typename Result, typename F>
+	std::vector<Result> scan(Reader& reader, F&& f, unsigned threads = 0) {
+		Offset size = reader.size();
+		Offset partition = scanPartitionSize(reader);
+		size_t count = partition > 0 ? (size_t)((size + partition - 1) / partition) : 0;
+
+		std::vector<Result> results(count);
+
+		// One Cursor per worker, such that the stream definitions that were
+		// loaded for one Unit are reused for the next.
+		threads = parallelThreads(count, threads);
+		std::vector<Cursor> cursors;
+		cursors.reserve(threads);
+		for(unsigned t = 0; t < threads; t++)
+			cursors.emplace_back(reader.cursor());
+
+		parallelFor(count, [&](size_t i, unsigned worker) {
+			Offset start = (Offset)i * partition;
+			Offset end = start + partition;
+
+			Cursor& c = cursors[worker];
+			c.seek(start);
+
+			for(Frame const* frame = &c.nextFrame();
+				frame->valid() && frame->header < end;
+				frame = &c.nextFrame())
+			{
+				if(frame->header >= start)
+					f(c, *frame, results[i]);
+			}
+		}, threads);
+
+		return results;
+	}
+
+} // namespace
+
+#endif // __cplusplus
+#endif // RTC_SCAN_H
@@ -22,9 +22,33 @@
 
 #include <utility>
 #include <functional>
+#include <cstddef>
 
 namespace rtc {
 
+	/*!
+	 * \brief A non-owning view on a range of bytes.
+	 */
+	class View {
+	public:
+		View() = default;
+
+		View(unsigned char const* data, size_t size)
+			: m_data(data), m_size(size)
+		{}
+
+		unsigned char const* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+		unsigned char const* begin() const { return m_data; }
+		unsigned char const* end() const { return m_data + m_size; }
+		unsigned char operator[](size_t i) const { return m_data[i]; }
+
+	private:
+		unsigned char const* m_data = nullptr;
+		size_t m_size = 0;
+	};
+
 	class Scope {
 	public:
 		template <typename F>
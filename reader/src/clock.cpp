@@ -0,0 +1,152 @@
+/*
+ * Ruler Trace Container
+ * Copyright (C) 2020-2021  Jochem Rutgers
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rtc/clock.h"
+#include "rtc/exception.h"
+#include "rtc/reader.h"
+
+#include <cstring>
+
+namespace rtc {
+
+Clock::Clock(Stream const& stream)
+	: m_stream(&stream)
+	, m_delta(stream.meta().value("delta", ""))
+	, m_gain(stream.meta().value("gain", 1.0))
+	, m_offset(stream.meta().value("offset", 0.0))
+{
+	if(!isClock(stream))
+		throw std::invalid_argument("stream is not a clock");
+}
+
+bool Clock::isClock(Stream const& stream) {
+	auto it = stream.meta().find("clock");
+	return it != stream.meta().end() && it->is_boolean() && it->get<bool>();
+}
+
+Stream const& Clock::stream() const {
+	return *m_stream;
+}
+
+bool Clock::isDelta() const {
+	return !m_delta.empty();
+}
+
+std::string const& Clock::delta() const {
+	return m_delta;
+}
+
+Time Clock::decode(View payload) const {
+	return decodeNumber(stream().format(), payload) * m_gain + m_offset;
+}
+
+static bool littleEndian() {
+	uint16_t x = 1;
+	unsigned char b;
+	memcpy(&b, &x, 1);
+	return b == 1;
+}
+
+template <typename T>
+static T decodeFixed(View payload, bool swap) {
+	if(payload.size() < sizeof(T))
+		throw FormatError("Frame too short");
+
+	unsigned char buf[sizeof(T)];
+	for(size_t i = 0; i < sizeof(T); i++)
+		buf[i] = payload[swap ? sizeof(T) - 1u - i : i];
+
+	T x;
+	memcpy(&x, buf, sizeof(T));
+	return x;
+}
+
+double decodeNumber(std::string const& format, View payload) {
+	if(format == "timespec") {
+		uint64_t sec = decodeFixed<uint64_t>(payload, false);
+		uint32_t nsec = decodeFixed<uint32_t>(View(payload.data() + 8, payload.size() < 8 ? 0 : payload.size() - 8), false);
+		return (double)sec + (double)nsec * 1e-9;
+	}
+
+	char const* f = format.c_str();
+	bool isUnsigned = *f == 'u';
+	if(isUnsigned)
+		f++;
+
+	if(strcmp(f, "leb128") == 0) {
+		uint64_t x = 0;
+		size_t len = Reader::decodeInt(payload.data(), payload.size(), x);
+		if(isUnsigned)
+			return (double)x;
+
+		// Sign extend.
+		size_t bits = len * 7u;
+		if(bits < 64 && (x & ((uint64_t)1 << (bits - 1u))))
+			x |= ~(uint64_t)0 << bits;
+		return (double)(int64_t)x;
+	}
+
+	bool isFloat = false;
+	if(strncmp(f, "int", 3) == 0) {
+		f += 3;
+	} else if(!isUnsigned && strncmp(f, "float", 5) == 0) {
+		isFloat = true;
+		f += 5;
+	} else {
+		throw FormatError("Unsupported format %s", format.c_str());
+	}
+
+	char* end = nullptr;
+	unsigned long bits = strtoul(f, &end, 10);
+
+	bool swap = false;
+	if(strcmp(end, "le") == 0)
+		swap = !littleEndian();
+	else if(strcmp(end, "be") == 0)
+		swap = littleEndian();
+	else if(*end)
+		throw FormatError("Unsupported format %s", format.c_str());
+
+	if(isFloat) {
+		switch(bits) {
+		case 32: return (double)decodeFixed<float>(payload, swap);
+		case 64: return decodeFixed<double>(payload, swap);
+		default: break;
+		}
+	} else if(isUnsigned) {
+		switch(bits) {
+		case 8: return (double)decodeFixed<uint8_t>(payload, swap);
+		case 16: return (double)decodeFixed<uint16_t>(payload, swap);
+		case 32: return (double)decodeFixed<uint32_t>(payload, swap);
+		case 64: return (double)decodeFixed<uint64_t>(payload, swap);
+		default: break;
+		}
+	} else {
+		switch(bits) {
+		case 8: return (double)decodeFixed<int8_t>(payload, swap);
+		case 16: return (double)decodeFixed<int16_t>(payload, swap);
+		case 32: return (double)decodeFixed<int32_t>(payload, swap);
+		case 64: return (double)decodeFixed<int64_t>(payload, swap);
+		default: break;
+		}
+	}
+
+	throw FormatError("Unsupported format %s", format.c_str());
+}
+
+} // namespace
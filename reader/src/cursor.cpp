@@ -21,6 +21,7 @@
 #include "rtc/reader.h"
 
 #include <cassert>
+#include <limits>
 
 #define MARKER_FRAME_SIZE ((size_t)1 + Reader::MarkerBlock)
 
@@ -37,7 +38,7 @@ Reader& Cursor::reader() const {
 }
 
 void Cursor::reset() {
-	m_pos = reader().pos();
+	m_pos = 0;
 	m_eof = false;
 	m_aligned = false;
 	m_Marker = -1;
@@ -55,9 +56,6 @@ Offset Cursor::pos() const {
 
 void Cursor::seek(Offset offset) {
 	m_aligned = false;
-	if(offset >= 0)
-		reader().seek(offset, SEEK_SET);
-
 	seekUnsafe(offset);
 }
 
@@ -65,8 +63,10 @@ void Cursor::seekUnsafe(Offset offset) {
 	if(offset >= 0) {
 		m_pos = offset;
 	} else {
-		reader().seek(offset, SEEK_END);
-		m_pos = reader().pos();
+		offset += reader().size();
+		if(offset < 0)
+			throw SeekError(EINVAL);
+		m_pos = offset;
 	}
 }
 
@@ -103,7 +103,6 @@ Frame const& Cursor::findMarker(bool forward) {
 		size_t res = read(&word, sizeof(word));
 		if(res != sizeof(word)) {
 			// End of file, cannot find Marker.
-			assert(reader().eof());
 			m_eof = true;
 			return m_frame;
 		}
@@ -152,7 +151,6 @@ try_next:
 			b = 0;
 			if(reader().read(end, &b, 1) != 1) {
 				// Error end not found. End of file.
-				assert(reader().eof());
 				m_eof = true;
 				return m_frame;
 			}
@@ -369,15 +367,297 @@ Frame const& Cursor::nextFrame() {
 	return nextMarker();
 }
 
+/*!
+ * \brief Decode the payload of a [Ii]ndex frame.
+ *
+ * \p f is called with the stream ID and the offset relative to the start of
+ * the index frame, for all streams that have an offset.
+ *
+ * \return the Unit count, or 0 if \p haveCount is \c false
+ */
+template <typename F>
+static uint64_t decodeIndex(std::vector<unsigned char> const& buffer, bool haveCount, F&& f) {
+	size_t decoded = 0;
+	uint64_t count = 0;
+
+	if(haveCount)
+		decoded += Reader::decodeInt(&buffer[decoded], buffer.size() - decoded, count);
+	while(decoded < buffer.size()) {
+		uint64_t id;
+		uint64_t off;
+
+		decoded += Reader::decodeInt(&buffer[decoded], buffer.size() - decoded, id);
+		if(!(id & 1u))
+			throw FormatError("Wrong entry ID");
+		id >>= 1u;
+
+		decoded += Reader::decodeInt(&buffer[decoded], buffer.size() - decoded, off);
+		if((off & 1))
+			throw FormatError("Wrong entry offset");
+		off >>= 1u;
+
+		if(off)
+			f((Stream::Id)id, (Offset)off);
+	}
+
+	return count;
+}
+
 Frame const& Cursor::nextFrame(Stream const& stream) {
-	// TODO: do smarter; skip full [Uu]nits when there are no frames expected
-	// in there of the given stream.
+	Stream::Id id = stream.id();
+
+	// Default streams are not (all) in the index. Continuations of a frame
+	// are never in the index; it follows after the next [Ii]ndex.
+	bool skip = id >= RTC_STREAM_DEFAULT_COUNT
+		&& !(currentFrame() && currentFrame().more && currentFrame().stream->id() == id);
+
+	Offset scanUntil = -1;
 
-	while(nextFrame())
-		if(currentFrame().stream->id() == stream.id())
+	while(true) {
+		if(skip && pos() >= scanUntil) {
+			Offset next = skipUnits(id, scanUntil);
+			if(next >= 0) {
+				seekUnsafe(next);
+				if(parseFrame() && currentFrame().stream->id() == id)
+					return currentFrame();
+
+				// Index is wrong. Scan the rest of this unit.
+				scanUntil = next + unit();
+			}
+		}
+
+		if(!nextFrame())
+			return currentFrame();
+		if(currentFrame().stream->id() == id)
 			return currentFrame();
+	}
+}
 
-	return currentFrame();
+Offset Cursor::skipUnits(Stream::Id id, Offset& scanUntil) {
+	// Assume we have to scan till the end of the file, unless the index tells
+	// otherwise.
+	scanUntil = std::numeric_limits<Offset>::max();
+
+	if(!aligned())
+		return -1;
+
+	Offset from = pos();
+	if(currentFrame() && currentFrame().header == from)
+		from = currentFrame().payload + (Offset)currentFrame().length;
+
+	auto scope = stashPos();
+
+	if(Unit() <= 0 || unit() <= 0)
+		// Load the Index to learn the Unit and unit sizes.
+		index(RTC_STREAM_Index);
+	if(Unit() <= 0 || unit() <= 0 || m_Marker < 0)
+		return -1;
+
+	while(true) {
+		// Find the unit that contains from, and the [Ii]ndex frame after it.
+		Offset Marker = from - m_Marker >= 0
+			? (from - m_Marker) / Unit() * Unit() + m_Marker
+			: m_Marker - (m_Marker - from + Unit() - 1) / Unit() * Unit();
+		Offset Index = Marker + (Offset)MARKER_FRAME_SIZE;
+		Offset unitStart = from;
+		Offset nextIndex = Index;
+
+		if(from >= Index) {
+			unitStart = (from - Index) / unit() * unit() + Index;
+			nextIndex = unitStart + unit();
+			if(nextIndex >= Marker + Unit())
+				nextIndex = Marker + Unit() + (Offset)MARKER_FRAME_SIZE;
+		}
+
+		Offset entry;
+		try {
+			entry = indexEntry(nextIndex, id);
+		} catch(Exception&) {
+			// No (valid) index there. Scan till the next Unit.
+			scanUntil = Marker + Unit() + (Offset)MARKER_FRAME_SIZE;
+			return -1;
+		}
+
+		if(entry >= from)
+			// First frame of the stream after from.
+			return entry;
+
+		if(entry >= unitStart) {
+			// The stream is in this unit, but the index cannot tell if there
+			// are more after from.
+			scanUntil = nextIndex;
+			return -1;
+		}
+
+		// The stream is not in this unit.
+		from = nextIndex;
+	}
+}
+
+Offset Cursor::indexEntry(Offset indexFrame, Stream::Id id) {
+	seekUnsafe(indexFrame);
+
+	auto const& f = parseFrame(false);
+	if(!f || !f.stream)
+		throw FormatError("No index frame");
+
+	bool haveCount = false;
+	switch(f.stream->id()) {
+	case RTC_STREAM_Index:
+		haveCount = true;
+		break;
+	case RTC_STREAM_index:
+		break;
+	default:
+		throw FormatError("Wrong stream");
+	}
+
+	Offset res = -1;
+	decodeIndex(fullFrame(), haveCount, [&](Stream::Id entryId, Offset offset) {
+		if(entryId == id)
+			res = indexFrame - offset;
+	});
+
+	return res;
+}
+
+/*!
+ * \brief Move to the frame of the given clock that is in effect at time \p t.
+ *
+ * That is the last frame of \p clock with a time less than or equal to \p
+ * t, or the first one when \p t is before the start of the trace.  The Units
+ * are bisected on the first absolute clock frame after their Marker, which
+ * the index lets us find without scanning.  When \p interpolate is set, the
+ * probe is taken at the interpolated position of \p t instead, alternated
+ * with plain bisection to bound the worst case.  The search finishes with a
+ * forward scan within the last Unit.
+ *
+ * For a delta clock, the time of a frame is the delta applied to the last
+ * frame of the base clock.  When \p t falls before the first delta frame
+ * after the nearest base frame, the cursor is left at that base frame.
+ */
+Frame const& Cursor::seekTime(Stream const& clock, Time t, bool interpolate) {
+	Clock c(clock);
+	Stream const* abs = &clock;
+	if(c.isDelta()) {
+		abs = stream(c.delta());
+		if(!abs)
+			throw FormatError("Unknown clock %s", c.delta().c_str());
+	}
+
+	Clock absClock(*abs);
+
+	auto decode = [&](Clock const& ck) {
+		if(!currentFrame().more)
+			return ck.decode(payload(currentFrame()));
+
+		auto buffer = fullFrame();
+		return ck.decode(View(buffer.data(), buffer.size()));
+	};
+
+	// Find the first absolute clock frame from the start of the given Unit.
+	Offset probed = -1;
+	auto probe = [&](Offset Unit, Time& time) -> Offset {
+		seek(Unit > 0 ? Unit * this->Unit() : 0);
+		probed = Unit;
+		if(!nextFrame(*abs))
+			return -1;
+
+		Offset o = currentFrame().header;
+		time = decode(absClock);
+		return o;
+	};
+
+	seek(0);
+	if(!nextFrame())
+		return m_frame = Frame();
+
+	index(RTC_STREAM_Index);
+	Offset size = reader().size();
+	Offset Units = Unit() > 0 ? (size + Unit() - 1) / Unit() : 1;
+
+	Time tlo = 0;
+	Offset lo = 0;
+	Offset olo = probe(0, tlo);
+	if(olo < 0)
+		// No clock frames at all.
+		return m_frame = Frame();
+
+	if(tlo > t) {
+		// Before the start of the trace.
+		if(abs != &clock && nextFrame(clock))
+			return currentFrame();
+
+		seekUnsafe(olo);
+		return parseFrame();
+	}
+
+	{
+		Offset hi = Units;
+		Time thi = 0;
+		bool haveThi = false;
+		bool bisect = !interpolate;
+
+		while(hi - lo > 1) {
+			Offset mid = lo + (hi - lo) / 2;
+
+			if(!bisect && haveThi && thi > tlo) {
+				mid = lo + (Offset)((t - tlo) / (thi - tlo) * (double)(hi - lo));
+				mid = std::max(lo + 1, std::min(hi - 1, mid));
+			}
+
+			bisect = interpolate && !bisect;
+
+			Time tm = 0;
+			Offset om = probe(mid, tm);
+			if(om < 0 || tm > t) {
+				hi = mid;
+				thi = tm;
+				haveThi = om >= 0;
+			} else {
+				lo = mid;
+				tlo = tm;
+				olo = om;
+			}
+		}
+	}
+
+	// Scan forward from the absolute clock frame at or before t.
+	if(probed != lo)
+		probe(lo, tlo);
+
+	assert(currentFrame().header == olo);
+
+	Offset result = abs == &clock ? olo : -1;
+	Time base = tlo;
+
+	while(nextFrame()) {
+		Frame const& f = currentFrame();
+
+		if(f.stream->id() == abs->id()) {
+			Offset o = f.header;
+			Time tf = decode(absClock);
+			if(tf > t)
+				break;
+
+			base = tf;
+			if(abs == &clock)
+				result = o;
+		} else if(f.stream->id() == clock.id()) {
+			Offset o = f.header;
+			Time tf = base + decode(c);
+			if(tf > t)
+				break;
+
+			result = o;
+		}
+	}
+
+	if(result < 0)
+		result = olo;
+
+	seekUnsafe(result);
+	return parseFrame();
 }
 
 Cursor& Cursor::operator++() {
@@ -416,6 +696,7 @@ Stream const* Cursor::stream(Stream::Id id, bool autoLoadMeta) {
 	auto here = stashPos();
 
 	assert(m_Marker >= 0);
+	Offset unitStart = currentUnitStart();
 
 	try {
 		// Move to next Meta, which is probably of the next Unit.
@@ -424,6 +705,21 @@ Stream const* Cursor::stream(Stream::Id id, bool autoLoadMeta) {
 		if(nextMeta() || prevMeta()) {
 			// Load the frame that is at the current cursor.
 			loadMeta();
+		} else if(unitStart >= 0) {
+			// There are not enough Units around to follow the Index.
+			// The writer puts the Meta right after this Unit's Index.
+			m_Marker = unitStart;
+			m_aligned = true;
+			seekUnsafe(unitStart + MARKER_FRAME_SIZE);
+			auto const& f = parseFrame(false);
+			if(f && f.stream && f.stream->id() == RTC_STREAM_Index) {
+				seekUnsafe(f.payload + (Offset)f.length);
+				auto const& m = parseFrame(false);
+				if(m && m.stream && m.stream->id() == RTC_STREAM_Meta) {
+					seekUnsafe(m.header);
+					loadMeta();
+				}
+			}
 		}
 
 	} catch(SeekError&) {
@@ -436,6 +732,18 @@ Stream const* Cursor::stream(Stream::Id id, bool autoLoadMeta) {
 	return it == m_streams.end() ? nullptr : it->second.get();
 }
 
+Stream const* Cursor::stream(std::string const& name) const {
+	for(auto const& s : m_streams)
+		if(s.second->name() == name)
+			return s.second.get();
+
+	for(auto const& s : defaultStreams)
+		if(s.name() == name)
+			return &s;
+
+	return nullptr;
+}
+
 Frame const& Cursor::parseFrame(bool autoLoadMeta) {
 	m_eof = false;
 
@@ -468,9 +776,11 @@ Frame const& Cursor::parseFrame(bool autoLoadMeta) {
 		}
 
 		return m_frame = frame;
+	} catch(EofError&) {
+		m_eof = true;
+		return m_frame = Frame();
 	} catch(FormatError&) {
 		// Cannot parse bytes.
-		m_eof = reader().eof();
 		return m_frame = Frame();
 	}
 }
@@ -566,13 +876,26 @@ std::vector<unsigned char> Cursor::fullFrame() {
 			size_t offset = buffer.size();
 			buffer.resize(buffer.size() + f.length);
 			if(reader().read(f.payload, &buffer[offset], f.length) != f.length)
-				throw FormatError("EOF");
+				throw EofError();
 		}
 	});
 
 	return buffer;
 }
 
+View Cursor::payload(Frame const& frame) {
+	if(!frame.valid() || frame.length == 0)
+		return View();
+
+	if(reader().isMapped())
+		// Zero copy.
+		return reader().view(frame.payload, frame.length);
+
+	m_payload.resize(frame.length);
+	size_t len = reader().read(frame.payload, m_payload.data(), frame.length);
+	return View(m_payload.data(), len);
+}
+
 void Cursor::loadIndex() {
 	// The Index and index are always one ore more consecutive frames.
 	// There are never interrupted by other frames.
@@ -593,30 +916,12 @@ void Cursor::loadIndex() {
 		throw FormatError("Wrong stream");
 	}
 
-	// Copy full index to a buffer.
-	auto buffer = fullFrame();
-
-	size_t decoded = 0;
+	uint64_t count = decodeIndex(fullFrame(), haveCount, [&](Stream::Id id, Offset offset) {
+		m_index[id] = here - offset;
+	});
 
 	if(haveCount)
-		decoded += Reader::decodeInt(&buffer[decoded], buffer.size() - decoded, m_IndexCount);
-	while(decoded < buffer.size()) {
-		uint64_t id;
-		uint64_t off;
-
-		decoded += Reader::decodeInt(&buffer[decoded], buffer.size() - decoded, id);
-		if(!(id & 1u))
-			throw FormatError("Wrong entry ID");
-		id >>= 1u;
-
-		decoded += Reader::decodeInt(&buffer[decoded], buffer.size() - decoded, off);
-		if((off & 1))
-			throw FormatError("Wrong entry offset");
-		off >>= 1u;
-
-		if(off)
-			m_index[(Stream::Id)id] = here - (Offset)off;
-	}
+		m_IndexCount = count;
 
 	if(haveCount) {
 		auto it = m_index.find(RTC_STREAM_Index);
@@ -647,7 +952,7 @@ void Cursor::loadMeta() {
 	// Copy full index to a buffer.
 	auto buffer = fullFrame();
 
-	auto j = json::parse((char const*)buffer.data());
+	auto j = json::parse(buffer.begin(), buffer.end());
 	if(!j.is_array() || j.size() < 1)
 		throw FormatError("JSON format error");
 
@@ -19,6 +19,16 @@
 #include "rtc/cursor.h"
 #include "rtc/reader.h"
 
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+#ifdef _POSIX_C_SOURCE
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 namespace rtc {
 
 Reader::Reader()
@@ -32,7 +42,7 @@ Reader::~Reader() {
 	}
 }
 
-void Reader::open(char const* filename) {
+void Reader::open(char const* filename, int mode) {
 	close();
 
 	if(!filename)
@@ -43,16 +53,98 @@ void Reader::open(char const* filename) {
 		throw Exception(errno, "Cannot open '%s';", filename);
 
 	m_file = f;
+#ifdef _POSIX_C_SOURCE
+	m_fd = fileno(f);
+#endif
+
+	if(mode & ModeMap)
+		map(mode);
+}
+
+void Reader::map(int mode) {
+#ifdef _POSIX_C_SOURCE
+	int fd = m_fd;
+	struct stat st;
+	if(fstat(fd, &st))
+		throw Exception(errno, "Cannot stat file");
+
+	m_mapped = true;
+	m_mapSize = (size_t)st.st_size;
+
+	if(m_mapSize == 0)
+		// Nothing to map.
+		return;
+
+	int flags = MAP_PRIVATE;
+#  ifdef MAP_POPULATE
+	if(mode & ModePopulate)
+		flags |= MAP_POPULATE;
+#  endif
+
+	void* p = mmap(nullptr, m_mapSize, PROT_READ, flags, fd, 0);
+	if(p == MAP_FAILED) {
+		int e = errno;
+		m_mapped = false;
+		m_mapSize = 0;
+		throw Exception(e, "Cannot map file");
+	}
+
+	m_map = static_cast<unsigned char const*>(p);
+
+	// Hints only; ignore errors.
+	if(mode & ModeSequential)
+		madvise(p, m_mapSize, MADV_SEQUENTIAL);
+#  ifdef MADV_HUGEPAGE
+	if(mode & ModeHugePages)
+		madvise(p, m_mapSize, MADV_HUGEPAGE);
+#  endif
+#else
+	(void)mode;
+	throw Exception("Memory mapping is not supported");
+#endif
+}
+
+void Reader::unmap() {
+#ifdef _POSIX_C_SOURCE
+	if(m_map)
+		munmap(const_cast<unsigned char*>(m_map), m_mapSize);
+#endif
+
+	m_map = nullptr;
+	m_mapSize = 0;
+	m_mapped = false;
+}
+
+void Reader::setCache(size_t blocks, size_t blockSize) {
+	if(blocks > 0 && blockSize == 0)
+		throw std::invalid_argument("blockSize");
+
+	flushCache();
+	m_cacheBlocks = blocks;
+	m_cacheBlockSize = blockSize;
+}
+
+void Reader::flushCache() {
+	std::lock_guard<std::mutex> lock(m_cacheLock);
+	m_cacheIndex.clear();
+	m_cache.clear();
+}
+
+Reader::CacheStats Reader::cacheStats() const {
+	std::lock_guard<std::mutex> lock(m_cacheLock);
+	return m_cacheStats;
 }
 
 void Reader::open(FILE* f) {
 	close();
 
-	if(f)
+	if(!f)
 		throw std::invalid_argument("f");
 
 	m_file = f;
-	seek(0, SEEK_SET);
+#ifdef _POSIX_C_SOURCE
+	m_fd = fileno(f);
+#endif
 }
 
 #ifdef _POSIX_C_SOURCE
@@ -64,11 +156,14 @@ void Reader::open(int fd) {
 		throw Exception(errno, "Cannot open fd %d", fd);
 
 	m_file = f;
-	seek(0, SEEK_SET);
+	m_fd = fd;
 }
 #endif
 
 void Reader::close() {
+	unmap();
+	flushCache();
+
 	if(!m_file)
 		return;
 
@@ -76,49 +171,52 @@ void Reader::close() {
 		throw Exception(errno, "Cannot close file");
 
 	m_file = nullptr;
+	m_fd = -1;
 }
 
 FILE* Reader::file() const {
 	return m_file;
 }
 
-bool Reader::eof() const {
-	return feof(file()) != 0; // error is also reported as EOF
-}
-
 bool Reader::isOpen() const {
 	return file() != nullptr;
 }
 
-Offset Reader::pos() {
+bool Reader::isMapped() const {
+	return m_mapped;
+}
+
+Offset Reader::size() const {
 	if(!isOpen())
 		throw Exception("File is not open");
+	if(isMapped())
+		return (Offset)m_mapSize;
 
-#ifdef WIN32
-	intptr_t res = (intptr_t)_ftelli64(file());
+#ifdef _POSIX_C_SOURCE
+	struct stat st;
+	if(fstat(m_fd, &st))
+		throw Exception(errno, "Cannot stat file");
+
+	return (Offset)st.st_size;
 #else
-	intptr_t res = (intptr_t)ftell(file());
-#endif
+	std::lock_guard<std::mutex> lock(m_fileLock);
 
-	if(res == -1) {
-		int e = errno;
-		close();
-		throw Exception(e, "Cannot get current file position");
-	}
+#  ifdef WIN32
+	if(_fseeki64(file(), 0, SEEK_END))
+		throw SeekError(errno);
 
-	return res;
-}
+	intptr_t res = (intptr_t)_ftelli64(file());
+#  else
+	if(fseek(file(), 0, SEEK_END))
+		throw SeekError(errno);
 
-void Reader::seek(Offset offset, int whence) {
-	if(!isOpen())
-		throw SeekError("File is not open");
+	intptr_t res = (intptr_t)ftell(file());
+#  endif
 
-#ifdef WIN32
-	if(_fseeki64(file(), offset, whence))
-		throw SeekError(errno);
-#else
-	if(fseek(file(), (long)offset, whence))
-		throw SeekError(errno);
+	if(res == -1)
+		throw Exception(errno, "Cannot get file size");
+
+	return res;
 #endif
 }
 
@@ -134,13 +232,53 @@ size_t Reader::read(Offset offset, void* dst, size_t len) {
 	if(!dst)
 		throw std::invalid_argument("dst");
 
-	if(m_pos != offset) {
-		seek(offset, SEEK_SET);
-		m_pos = offset;
+	size_t res;
+
+	if(isMapped()) {
+		View v = view(offset, len);
+		memcpy(dst, v.data(), v.size());
+		res = v.size();
+	} else if(m_cacheBlocks > 0) {
+		res = readCached(offset, dst, len);
+	} else {
+		res = readFile(offset, dst, len);
+	}
+
+	return res;
+}
+
+size_t Reader::readFile(Offset offset, void* dst, size_t len) {
+	if(offset < 0)
+		throw SeekError(EINVAL);
+
+#ifdef _POSIX_C_SOURCE
+	char* dst_ = static_cast<char*>(dst);
+	size_t done = 0;
+
+	while(done < len) {
+		ssize_t res = pread(m_fd, dst_ + done, len - done, (off_t)(offset + (Offset)done));
+		if(res > 0)
+			done += (size_t)res;
+		else if(res == 0)
+			// EOF
+			break;
+		else if(errno != EINTR)
+			throw Exception(errno, "Cannot read file");
 	}
 
+	return done;
+#else
+	std::lock_guard<std::mutex> lock(m_fileLock);
+
+#  ifdef WIN32
+	if(_fseeki64(file(), offset, SEEK_SET))
+		throw SeekError(errno);
+#  else
+	if(fseek(file(), (long)offset, SEEK_SET))
+		throw SeekError(errno);
+#  endif
+
 	size_t res = fread(dst, 1, len, file());
-	m_pos += res;
 	if(res < len) {
 		if(ferror(file())) {
 			clearerr(file());
@@ -150,15 +288,114 @@ size_t Reader::read(Offset offset, void* dst, size_t len) {
 	}
 
 	return res;
+#endif
+}
+
+size_t Reader::readCached(Offset offset, void* dst, size_t len) {
+	if(offset < 0)
+		throw SeekError(EINVAL);
+
+	unsigned char* dst_ = static_cast<unsigned char*>(dst);
+	size_t done = 0;
+
+	while(done < len) {
+		Offset o = offset + (Offset)done;
+		Offset blockOffset = o - o % (Offset)m_cacheBlockSize;
+		size_t blockPos = (size_t)(o - blockOffset);
+		size_t chunk = std::min(len - done, m_cacheBlockSize - blockPos);
+
+		{
+			std::lock_guard<std::mutex> lock(m_cacheLock);
+
+			auto it = m_cacheIndex.find(blockOffset);
+			if(it != m_cacheIndex.end() && it->second->size >= blockPos + chunk) {
+				// Hit. Move to the front of the LRU list.
+				m_cacheStats.hits++;
+				m_cache.splice(m_cache.begin(), m_cache, it->second);
+				memcpy(dst_ + done, it->second->data.get() + blockPos, chunk);
+				done += chunk;
+				continue;
+			}
+
+			// Miss, or a short block at EOF that may have grown since.
+			m_cacheStats.misses++;
+		}
+
+		// Do the actual read without holding the lock, such that other
+		// threads can be served from the cache meanwhile.
+		CacheBlock b;
+		b.offset = blockOffset;
+		b.data.reset(new unsigned char[m_cacheBlockSize]);
+		b.size = readFile(blockOffset, b.data.get(), m_cacheBlockSize);
+
+		bool eof = b.size < m_cacheBlockSize;
+
+		if(blockPos < b.size) {
+			chunk = std::min(chunk, b.size - blockPos);
+			memcpy(dst_ + done, b.data.get() + blockPos, chunk);
+			done += chunk;
+		} else {
+			eof = true;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_cacheLock);
+
+			auto it = m_cacheIndex.find(blockOffset);
+			if(it != m_cacheIndex.end()) {
+				// Another thread got here first. Keep the most complete one.
+				if(it->second->size < b.size)
+					*it->second = std::move(b);
+				m_cache.splice(m_cache.begin(), m_cache, it->second);
+			} else {
+				m_cache.push_front(std::move(b));
+				m_cacheIndex[blockOffset] = m_cache.begin();
+
+				while(m_cache.size() > m_cacheBlocks) {
+					// Evict the least recently used block.
+					m_cacheIndex.erase(m_cache.back().offset);
+					m_cache.pop_back();
+				}
+			}
+		}
+
+		if(eof)
+			break;
+	}
+
+	return done;
+}
+
+View Reader::view(Offset offset, size_t len) const {
+	if(!isMapped() || offset < 0 || (size_t)offset >= m_mapSize)
+		return View();
+
+	return View(m_map + offset, std::min(len, m_mapSize - (size_t)offset));
 }
 
 size_t Reader::readInt(Offset offset, uint64_t& dst) {
 	unsigned char buf[10]; // Maximum length of encoded 64-bit value.
-	size_t buflen = read(offset, buf, sizeof(buf));
-	return decodeInt(buf, buflen, dst);
+	unsigned char const* p = buf;
+	size_t buflen;
+
+	if(isMapped()) {
+		View v = view(offset, sizeof(buf));
+		p = v.data();
+		buflen = v.size();
+	} else {
+		buflen = read(offset, buf, sizeof(buf));
+	}
+
+	try {
+		return decodeInt(p, buflen, dst);
+	} catch(FormatError&) {
+		if(buflen < sizeof(buf))
+			throw EofError();
+		throw;
+	}
 }
 
-size_t Reader::decodeInt(unsigned char* buffer, size_t len, uint64_t& dst) {
+size_t Reader::decodeInt(unsigned char const* buffer, size_t len, uint64_t& dst) {
 	dst = 0;
 	unsigned int shift = 0;
 	size_t i = 0;
@@ -185,10 +422,8 @@ crc_t Reader::crc(Offset start, Offset end) {
 #else
 	if(start < 0)
 		start = 0;
-	if(end < 0) {
-		seek(0, SEEK_END);
-		end = pos();
-	}
+	if(end < 0)
+		end = size();
 	if(start >= end)
 		return rtc_crc_end(rtc_crc_start());
 
@@ -200,10 +435,9 @@ crc_t Reader::crc(Offset start, Offset end) {
 		crc = rtc_crc(crc, buffer, r);
 		i += r;
 
-		if(!r) {
-			assert(eof());
+		if(!r)
+			// EOF
 			break;
-		}
 	}
 
 	return rtc_crc_end(crc);
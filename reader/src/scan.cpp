@@ -0,0 +1,97 @@
+/*
+ * Ruler Trace Container
+ * Copyright (C) 2020-2021  Jochem Rutgers
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rtc/scan.h"
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace rtc {
+
+Offset scanPartitionSize(Reader& reader) {
+	Offset size = reader.size();
+
+	Cursor c = reader.cursor();
+	if(c.nextIndex()) {
+		// Load the Index to get the Unit size.
+		c.index(RTC_STREAM_Index);
+		if(c.Unit() > 0)
+			return c.Unit();
+	}
+
+	// No Index found, do it all at once.
+	return size;
+}
+
+unsigned parallelThreads(size_t count, unsigned threads) {
+	if(threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if(threads == 0)
+		threads = 1;
+	if(threads > count)
+		threads = (unsigned)count;
+
+	return threads;
+}
+
+void parallelFor(size_t count, std::function<void(size_t,unsigned)> const& f, unsigned threads) {
+	threads = parallelThreads(count, threads);
+	if(threads == 0)
+		return;
+
+	std::atomic<size_t> next{0};
+	std::atomic<bool> failed{false};
+	std::exception_ptr error;
+	std::mutex errorLock;
+
+	auto worker = [&](unsigned w) {
+		try {
+			size_t i;
+			while(!failed && (i = next++) < count)
+				f(i, w);
+		} catch(...) {
+			std::lock_guard<std::mutex> lock(errorLock);
+			if(!error)
+				error = std::current_exception();
+			failed = true;
+		}
+	};
+
+	if(threads <= 1) {
+		worker(0);
+	} else {
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1u);
+
+		// This thread participates too.
+		for(unsigned t = 1; t < threads; t++)
+			pool.emplace_back(worker, t);
+
+		worker(0);
+
+		for(auto& t : pool)
+			t.join();
+	}
+
+	if(error)
+		std::rethrow_exception(error);
+}
+
+} // namespace
@@ -30,6 +30,26 @@
 #define RTC_FRAME_MAX_PAYLOAD RTC_MARKER_BLOCK
 #define RTC_FRAME_MAX_SIZE (RTC_FRAME_MAX_HEADER_SIZE + RTC_FRAME_MAX_PAYLOAD)
 
+#ifdef RTC_Unit_SIZE
+typedef char rtc_check_Unit_size[
+	(RTC_Unit_SIZE) >= RTC_MIN_UNIT_SIZE && ((RTC_Unit_SIZE) & ((RTC_Unit_SIZE) - 1)) == 0 ? 1 : -1];
+#  define rtc_Unit_size(h)	((rtc_offset)(RTC_Unit_SIZE))
+#else
+#  define rtc_Unit_size(h)	((rtc_offset)(h)->param->Unit)
+#endif
+
+#ifdef RTC_unit_SIZE
+typedef char rtc_check_unit_size[
+	(RTC_unit_SIZE) > RTC_FRAME_MAX_SIZE && ((RTC_unit_SIZE) & ((RTC_unit_SIZE) - 1)) == 0 ? 1 : -1];
+#  define rtc_unit_size(h)	((rtc_offset)(RTC_unit_SIZE))
+#else
+#  define rtc_unit_size(h)	((rtc_offset)(h)->param->unit)
+#endif
+
+#if defined(RTC_Unit_SIZE) && defined(RTC_unit_SIZE)
+typedef char rtc_check_Unit_unit_size[(RTC_Unit_SIZE) >= (RTC_unit_SIZE) ? 1 : -1];
+#endif
+
 
 /**************************************
  * Utilities
@@ -67,7 +87,7 @@
 
 #ifdef __GCC__
 #  define rtc_popcount(x)	__builtin_popcountl(x)
-#else
+#elif !defined(RTC_Unit_SIZE) || !defined(RTC_unit_SIZE)
 static int rtc_popcount(size_t x) {
 	int cnt = 0;
 
@@ -176,8 +196,16 @@ void rtc_param_default(rtc_param* param) {
 		return;
 
 	memset(param, 0, sizeof(*param));
+#ifdef RTC_Unit_SIZE
+	param->Unit = RTC_Unit_SIZE;
+#else
 	param->Unit = 1 << 20;
+#endif
+#ifdef RTC_unit_SIZE
+	param->unit = RTC_unit_SIZE;
+#else
 	param->unit = 1 << 17;
+#endif
 }
 
 static rtc_stream_param const rtc_default_stream_param[RTC_STREAM_DEFAULT_COUNT] = {
@@ -185,59 +213,156 @@ static rtc_stream_param const rtc_default_stream_param[RTC_STREAM_DEFAULT_COUNT]
 		/* .name = */ "nop",
 		/* .frame_length = */ 0,
 		/* .json = */ "\"name\":\"nop\",\"length\":0",
-		/* .hidden = */ true
+		/* .hidden = */ true,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	},
 	{
 		/* .name = */ "padding",
 		/* .frame_length = */ RTC_STREAM_VARIABLE_LENGTH,
 		/* .json = */ "\"name\":\"padding\"",
-		/* .hidden = */ true
+		/* .hidden = */ true,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	},
 	{
 		/* .name = */ "Marker",
 		/* .frame_length = */ RTC_FRAME_MAX_PAYLOAD,
 		/* .json = */ "\"name\":\"Marker\",\"length\":" STRINGIFY(RTC_FRAME_MAX_PAYLOAD),
-		/* .hidden = */ true
+		/* .hidden = */ true,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	},
 	{
 		/* .name = */ "Index",
 		/* .frame_length = */ RTC_STREAM_VARIABLE_LENGTH,
 		/* .json = */ "\"name\":\"Index\",\"format\":\"index\"",
-		/* .hidden = */ false
+		/* .hidden = */ false,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	},
 	{
 		/* .name = */ "index",
 		/* .frame_length = */ RTC_STREAM_VARIABLE_LENGTH,
 		/* .json = */ "\"name\":\"index\",\"format\":\"index\"",
-		/* .hidden = */ false
+		/* .hidden = */ false,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	},
 	{
 		/* .name = */ "Meta",
 		/* .frame_length = */ RTC_STREAM_VARIABLE_LENGTH,
 		/* .json = */ "\"name\":\"Meta\",\"format\":\"json\"",
-		/* .hidden = */ false
+		/* .hidden = */ false,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	},
 	{
 		/* .name = */ "meta",
 		/* .frame_length = */ RTC_STREAM_VARIABLE_LENGTH,
 		/* .json = */ "\"name\":\"meta\",\"format\":\"json\"",
-		/* .hidden = */ true
+		/* .hidden = */ true,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	},
 	{
 		/* .name = */ "Platform",
 		/* .frame_length = */ sizeof(crc_t),
 		/* .json = */ "\"name\":\"Platform\",\"format\":\"platform\"",
-		/* .hidden = */ false
+		/* .hidden = */ false,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	},
 	{
 		/* .name = */ "Crc",
 		/* .frame_length = */ sizeof(crc_t),
 		/* .json = */ "\"name\":\"Crc\",\"format\":\"uint32\"",
-		/* .hidden = */ false
+		/* .hidden = */ false,
+		/* .combine_buffer = */ NULL,
+		/* .combine_size = */ 0,
+		/* .state_buffer = */ NULL,
+		/* .state_size = */ 0,
+		/* .limit = */ RTC_LIMIT_NONE,
+		/* .limit_n = */ 0,
+		/* .limit_burst = */ 0,
+		/* .limit_compare = */ NULL,
+		/* .limit_buffer = */ NULL
 	}
 };
 
 
+static rtc_stream_param const rtc_dropped_stream_param = {
+	/* .name = */ "Dropped",
+	/* .frame_length = */ RTC_STREAM_VARIABLE_LENGTH,
+	/* .json = */ "\"name\":\"Dropped\",\"format\":\"dropped\"",
+	/* .hidden = */ false,
+	/* .combine_buffer = */ NULL,
+	/* .combine_size = */ 0,
+	/* .state_buffer = */ NULL,
+	/* .state_size = */ 0,
+	/* .limit = */ RTC_LIMIT_NONE,
+	/* .limit_n = */ 0,
+	/* .limit_burst = */ 0,
+	/* .limit_compare = */ NULL,
+	/* .limit_buffer = */ NULL
+};
+
 
 /**************************************
  * JSON
@@ -290,6 +415,7 @@ int rtc_json(rtc_handle* h, rtc_write_callback* cb, bool defaults) {
  */
 
 static int rtc_meta(rtc_stream* s);
+static unsigned long rtc_now(rtc_handle* h);
 
 int rtc_create(rtc_handle* h, rtc_stream* s, rtc_stream_param const* param) {
 	rtc_stream* es;
@@ -303,6 +429,24 @@ int rtc_create(rtc_handle* h, rtc_stream* s, rtc_stream_param const* param) {
 	if(h->free_id && (h->free_id << 1u) == 0)
 		return ENOMEM;
 
+	switch(param->limit) {
+	case RTC_LIMIT_NONE:
+		break;
+	case RTC_LIMIT_MINMAX:
+		if(param->frame_length == RTC_STREAM_VARIABLE_LENGTH)
+			return EINVAL;
+		if(!param->limit_compare || !param->limit_buffer)
+			return EINVAL;
+		/* fall-through */
+	case RTC_LIMIT_BUCKET:
+	case RTC_LIMIT_DECIMATE:
+		if(!param->limit_n)
+			return EINVAL;
+		break;
+	default:
+		return EINVAL;
+	}
+
 	for(es = h->first_stream; es; es = es->next)
 		if(strcmp(es->param->name, param->name) == 0)
 			return EEXIST;
@@ -316,6 +460,10 @@ int rtc_create(rtc_handle* h, rtc_stream* s, rtc_stream_param const* param) {
 	assert(s->id_str_len < sizeof(s->id_str));
 	if(param->json)
 		s->param_json_len = strlen(param->json);
+	if(param->limit == RTC_LIMIT_BUCKET) {
+		s->limit_tokens = param->limit_burst ? param->limit_burst : param->limit_n;
+		s->limit_time = rtc_now(h);
+	}
 
 	if(h->cursor != h->Unit_end)
 		check_res(rtc_meta(s));
@@ -349,6 +497,8 @@ int rtc_open(rtc_handle* h, rtc_stream** s, char const* name) {
 	return ESRCH;
 }
 
+static int rtc_combine_flush(rtc_handle* h);
+
 int rtc_close(rtc_stream* s) {
 	if(!s)
 		return EINVAL;
@@ -360,6 +510,8 @@ int rtc_close(rtc_stream* s) {
 		s->open--;
 		return 0;
 	}
+	if(s->h->combining == s)
+		check_res(rtc_combine_flush(s->h));
 	if(s->used)
 		return EAGAIN;
 
@@ -386,7 +538,7 @@ int rtc_close(rtc_stream* s) {
  * Common frame functions
  */
 
-static int rtc_write_(rtc_stream* s, void const* buffer, size_t len, bool more, bool stayInUnit);
+static int rtc_write_(rtc_stream* s, void const* buffer, size_t len, bool more, bool stayInUnit, bool droppable);
 
 static int rtc_emit(rtc_handle* h, void const* buffer, size_t len, int flags) {
 	rtc_offset new_cursor = h->cursor + len;
@@ -406,6 +558,25 @@ static int rtc_emit(rtc_handle* h, void const* buffer, size_t len, int flags) {
 	return h->param->write(h, buffer, len, flags);
 }
 
+static int rtc_emit_frame(rtc_handle* h, char const* hdr, size_t hdrlen, void const* payload, size_t len, int flags) {
+	rtc_offset new_cursor = h->cursor + hdrlen + len;
+
+	if(new_cursor < h->cursor) {
+		/* Overflow. */
+		return ENOSPC;
+	}
+
+	/* The callback may refuse the frame as a whole by refusing its header. */
+	check_res(h->param->write(h, hdr, hdrlen, flags));
+
+	h->cursor = new_cursor;
+#ifndef RTC_NO_CRC
+	h->crc = rtc_crc(h->crc, hdr, hdrlen);
+	h->crc = rtc_crc(h->crc, payload, len);
+#endif
+	return h->param->write(h, payload, len, 0);
+}
+
 static size_t rtc_header(rtc_stream* s, size_t payload, char* hdr, bool more) {
 	size_t len = 0;
 
@@ -445,7 +616,7 @@ static int rtc_frame_append(rtc_stream* s, rtc_frame* frame, void const* buf, si
 		b += chunk;
 
 		if(frame->len == sizeof(frame->buffer) || !more) {
-			check_res(rtc_write_(s, frameBuffer_, frame->len, more, true));
+			check_res(rtc_write_(s, frameBuffer_, frame->len, more, true, false));
 			frame->len = 0;
 		}
 	}
@@ -545,8 +716,8 @@ static int rtc_Index(rtc_handle* h) {
 	if(unlikely(!s->index)) {
 		/* First Index, reflect params in Index's and index's index,
 		 * even though they point to before the beginning of the file. */
-		s->index = h->cursor - h->param->Unit;
-		h->default_streams[RTC_STREAM_index].index = h->cursor - h->param->unit;
+		s->index = h->cursor - rtc_Unit_size(h);
+		h->default_streams[RTC_STREAM_index].index = h->cursor - rtc_unit_size(h);
 	}
 
 	check_res(rtc_index_(s, true));
@@ -620,7 +791,7 @@ again:
 
 	/* This call should always emit only our frame. */
 	cursor = h->cursor;
-	check_res(rtc_write_(s, &crc, sizeof(crc), false, true));
+	check_res(rtc_write_(s, &crc, sizeof(crc), false, true, false));
 	assert(h->cursor - cursor == RTC_FRAME_CRC_SIZE);
 	(void)cursor;
 
@@ -676,11 +847,49 @@ static int rtc_Platform(rtc_handle* h) {
 	rtc_stream* s = &h->default_streams[RTC_STREAM_Platform];
 
 	assert(sizeof(x) == 4u);
-	return rtc_write_(s, &x, sizeof(x), false, false);
+	return rtc_write_(s, &x, sizeof(x), false, false, false);
+}
+
+static rtc_frame droppedFrame;
+
+static bool rtc_dropped_pending(rtc_stream* s) {
+	return s->dropped_frames != s->reported_frames || s->dropped_bytes != s->reported_bytes;
+}
+
+static int rtc_Dropped(rtc_handle* h) {
+	rtc_stream* s;
+	char entry[RTC_ENCODE_INT_BUF(h->free_id) + 2 * RTC_ENCODE_INT_BUF(rtc_offset)];
+	size_t entryLen = 0;
+
+	for(s = h->first_stream; s && !rtc_dropped_pending(s); s = s->next);
+
+	if(likely(!s))
+		/* Nothing to report. */
+		return 0;
+
+	if(!h->dropped.param)
+		check_res(rtc_create(h, &h->dropped, &rtc_dropped_stream_param));
+
+	for(; s; s = s->next) {
+		if(!rtc_dropped_pending(s))
+			continue;
+
+		/* Flush out previous entry. */
+		check_res(rtc_frame_append(&h->dropped, &droppedFrame, entry, entryLen, 0));
+		/* Assemble next entry. */
+		entryLen = rtc_encode_int(s->id, entry);
+		entryLen += rtc_encode_int(s->dropped_frames - s->reported_frames, entry + entryLen);
+		entryLen += rtc_encode_int(s->dropped_bytes - s->reported_bytes, entry + entryLen);
+		s->reported_frames = s->dropped_frames;
+		s->reported_bytes = s->dropped_bytes;
+	}
+
+	/* Flush out last entry. */
+	return rtc_frame_append(&h->dropped, &droppedFrame, entry, entryLen, RTC_FLAG_FLUSH);
 }
 
 static int rtc_start_Unit(rtc_handle* h) {
-	h->Unit_end = h->cursor + h->param->Unit;
+	h->Unit_end = h->cursor + rtc_Unit_size(h);
 
 	if(likely(h->cursor > 0)) {
 #ifndef RTC_NO_CRC
@@ -696,16 +905,17 @@ static int rtc_start_Unit(rtc_handle* h) {
 #endif
 
 	check_res(rtc_Marker(h));
-	h->unit_end = h->cursor + h->param->unit;
+	h->unit_end = h->cursor + rtc_unit_size(h);
 	check_res(rtc_Index(h));
 	check_res(rtc_Meta(h));
 	check_res(rtc_Platform(h));
+	check_res(rtc_Dropped(h));
 
 	return 0;
 }
 
 static int rtc_start_unit(rtc_handle* h) {
-	h->unit_end = h->cursor + h->param->unit;
+	h->unit_end = h->cursor + rtc_unit_size(h);
 	return rtc_index(h);
 }
 
@@ -714,16 +924,19 @@ static int rtc_start_unit(rtc_handle* h) {
  * Generic frame
  */
 
-static void rtc_set_index(rtc_stream* s) {
-	if(!s->index || s->index < s->h->unit_end - s->h->param->unit)
-		s->index = s->h->cursor;
+static void rtc_set_index(rtc_stream* s, rtc_offset pos) {
+	if(!s->index || s->index < s->h->unit_end - rtc_unit_size(s->h))
+		s->index = pos;
 }
 
-static int rtc_write_(rtc_stream* s, void const* buffer, size_t len, bool more, bool stayInUnit) {
+static void rtc_drop(rtc_stream* s, size_t len, bool complete);
+
+static int rtc_write_(rtc_stream* s, void const* buffer, size_t len, bool more, bool stayInUnit, bool droppable) {
 	char hdr[RTC_FRAME_MAX_HEADER_SIZE];
 	char const* buffer_ = (char const*)buffer;
 	rtc_handle* h = s->h;
 	bool first = true;
+	int flags = droppable ? RTC_FLAG_FRAME : 0;
 
 	if(len == 0)
 		return 0;
@@ -733,35 +946,46 @@ static int rtc_write_(rtc_stream* s, void const* buffer, size_t len, bool more,
 		size_t hdrlen = rtc_header(s, chunklen, hdr, more || chunklen != len);
 		size_t rem = MIN(h->Unit_end, h->unit_end) - h->cursor;
 
-		if(likely(rem >= hdrlen + chunklen)) {
-			/* Frame fits. */
-			if(first) {
-				rtc_set_index(s);
-				first = false;
+		if(likely(rem > hdrlen)) {
+			rtc_offset start = h->cursor;
+			bool split = rem < hdrlen + chunklen;
+			int res;
+
+			if(unlikely(split)) {
+				/* Write first chunk. */
+				chunklen = rem - hdrlen;
+				hdrlen = rtc_header(s, chunklen, hdr, true);
+				assert(hdrlen + chunklen <= rem);
 			}
-			check_res(rtc_emit(h, hdr, hdrlen, 0));
-			check_res(rtc_emit(h, buffer_, chunklen, 0));
-			s->used = true;
 
-			buffer_ += chunklen;
-			len -= chunklen;
-			continue;
-		} else if(rem > hdrlen) {
-			/* Write first chunk. */
-			chunklen = rem - hdrlen;
-			hdrlen = rtc_header(s, chunklen, hdr, true);
-			assert(hdrlen + chunklen <= rem);
+			res = rtc_emit_frame(h, hdr, hdrlen, buffer_, chunklen, flags);
+			if(unlikely(res)) {
+				if(res != EAGAIN || !(flags & RTC_FLAG_FRAME) || h->cursor != start)
+					return res;
+
+				/* The sink cannot keep up. Drop the whole frame. */
+				rtc_drop(s, len, !more);
+				s->drop = more;
+				/* The reader did not get the last state. */
+				s->state_len = 0;
+				return 0;
+			}
 
 			if(first) {
-				rtc_set_index(s);
+				rtc_set_index(s, start);
 				first = false;
 			}
-			check_res(rtc_emit(h, hdr, hdrlen, 0));
-			check_res(rtc_emit(h, buffer_, chunklen, 0));
+
+			/* Once started, the remainder of the frame cannot be dropped. */
+			flags = 0;
 			s->used = true;
 
 			buffer_ += chunklen;
 			len -= chunklen;
+
+			if(likely(!split))
+				continue;
+
 			rem -= hdrlen + chunklen;
 		}
 
@@ -784,7 +1008,159 @@ static int rtc_write_(rtc_stream* s, void const* buffer, size_t len, bool more,
 	return 0;
 }
 
+static unsigned long rtc_now(rtc_handle* h) {
+	if(h->param->time)
+		return h->param->time(h);
+
+	return (unsigned long)(h->cursor / rtc_unit_size(h));
+}
+
+static void rtc_drop(rtc_stream* s, size_t len, bool complete) {
+	s->dropped_bytes += len;
+	if(complete)
+		s->dropped_frames++;
+}
+
+static bool rtc_limit_bucket(rtc_stream* s, size_t len) {
+	rtc_stream_param const* p = s->param;
+	size_t burst = p->limit_burst ? p->limit_burst : p->limit_n;
+	unsigned long now = rtc_now(s->h);
+	unsigned long elapsed = now - s->limit_time;
+
+	s->limit_time = now;
+
+	if(elapsed >= (burst + p->limit_n - 1u) / p->limit_n)
+		s->limit_tokens = burst;
+	else
+		s->limit_tokens = MIN(burst, s->limit_tokens + (size_t)elapsed * p->limit_n);
+
+	if(len > s->limit_tokens)
+		return false;
+
+	s->limit_tokens -= len;
+	return true;
+}
+
+static bool rtc_limit_decimate(rtc_stream* s) {
+	bool pass = s->limit_count == 0;
+
+	if(++s->limit_count >= s->param->limit_n)
+		s->limit_count = 0;
+
+	return pass;
+}
+
+static int rtc_combine_flush(rtc_handle* h);
+
+static int rtc_limit_minmax(rtc_stream* s, void const* buffer, size_t len, bool more) {
+	rtc_stream_param const* p = s->param;
+	char* min = (char*)p->limit_buffer;
+	char* max = min + p->frame_length;
+	char* first;
+	char* second;
+
+	if(more || len != p->frame_length)
+		return EINVAL;
+
+	if(s->limit_count == 0) {
+		memcpy(min, buffer, len);
+		memcpy(max, buffer, len);
+		s->limit_min = s->limit_max = 0;
+	} else if(p->limit_compare(buffer, min, len) < 0) {
+		memcpy(min, buffer, len);
+		s->limit_min = s->limit_count;
+	} else if(p->limit_compare(buffer, max, len) > 0) {
+		memcpy(max, buffer, len);
+		s->limit_max = s->limit_count;
+	}
+
+	if(++s->limit_count < p->limit_n)
+		return 0;
+
+	/* Window complete. Emit the extremes in chronological order. */
+	s->limit_count = 0;
+	check_res(rtc_combine_flush(s->h));
+
+	if(s->limit_min == s->limit_max) {
+		s->dropped_frames += p->limit_n - 1u;
+		s->dropped_bytes += (p->limit_n - 1u) * len;
+		return rtc_write_(s, min, len, false, false, true);
+	}
+
+	s->dropped_frames += p->limit_n - 2u;
+	s->dropped_bytes += (p->limit_n - 2u) * len;
+
+	if(s->limit_min < s->limit_max) {
+		first = min;
+		second = max;
+	} else {
+		first = max;
+		second = min;
+	}
+
+	check_res(rtc_write_(s, first, len, false, false, true));
+	return rtc_write_(s, second, len, false, false, true);
+}
+
+static int rtc_combine_flush(rtc_handle* h) {
+	rtc_stream* s = h->combining;
+	size_t len;
+
+	if(!s)
+		return 0;
+
+	len = s->combine_len;
+	s->combine_len = 0;
+	h->combining = NULL;
+	return rtc_write_(s, s->param->combine_buffer, len, false, false, true);
+}
+
+static int rtc_combine(rtc_stream* s, void const* buffer, size_t len) {
+	rtc_handle* h = s->h;
+	size_t size = s->param->combine_size;
+
+	if(s->combine_len + len > size)
+		/* Does not fit anymore. */
+		check_res(rtc_combine_flush(h));
+
+	if(len >= size)
+		/* Too large to combine anyway. */
+		return rtc_write_(s, buffer, len, false, false, true);
+
+	memcpy((char*)s->param->combine_buffer + s->combine_len, buffer, len);
+	s->combine_len += len;
+	h->combining = s;
+
+	if(s->combine_len == size)
+		return rtc_combine_flush(h);
+
+	return 0;
+}
+
+static bool rtc_state_unchanged(rtc_stream* s, void const* buffer, size_t len) {
+	if(s->state_Unit_end != s->h->Unit_end)
+		/* Not emitted in this Unit yet. */
+		return false;
+
+	return len == s->state_len && memcmp(s->param->state_buffer, buffer, len) == 0;
+}
+
+static void rtc_state_save(rtc_stream* s, void const* buffer, size_t len) {
+	s->state_Unit_end = s->h->Unit_end;
+
+	if(len > s->param->state_size) {
+		/* Does not fit; always emit the next one. */
+		s->state_len = 0;
+		return;
+	}
+
+	memcpy(s->param->state_buffer, buffer, len);
+	s->state_len = len;
+}
+
 int rtc_write(rtc_stream* s, void const* buffer, size_t len, bool more) {
+	bool partial;
+
 	if(!s)
 		return EINVAL;
 	if(len == 0)
@@ -792,7 +1168,65 @@ int rtc_write(rtc_stream* s, void const* buffer, size_t len, bool more) {
 	if(!buffer)
 		return EINVAL;
 
-	return rtc_write_(s, buffer, len, more, false);
+	partial = s->more;
+	s->more = more;
+
+	if(!partial) {
+		/* Start of a new frame. */
+		switch(s->param->limit) {
+		case RTC_LIMIT_NONE:
+			s->drop = false;
+			break;
+		case RTC_LIMIT_MINMAX:
+			return rtc_limit_minmax(s, buffer, len, more);
+		case RTC_LIMIT_BUCKET:
+			s->drop = !rtc_limit_bucket(s, len);
+			break;
+		default:
+			s->drop = !rtc_limit_decimate(s);
+		}
+	} else if(s->param->limit == RTC_LIMIT_BUCKET && !s->drop) {
+		/* Charge the remainder of a frame that has been accepted already. */
+		s->limit_tokens -= MIN(s->limit_tokens, len);
+	}
+
+	if(unlikely(s->drop)) {
+		/* Drop the (remainder of the) frame. */
+		rtc_drop(s, len, !more);
+		return 0;
+	}
+
+	if(s->param->state_buffer) {
+		if(more || partial) {
+			/* Only complete frames can be compared. */
+			s->state_len = 0;
+		} else if(rtc_state_unchanged(s, buffer, len)) {
+			return 0;
+		} else {
+			rtc_state_save(s, buffer, len);
+		}
+	}
+
+	if(s->param->combine_buffer && !more) {
+		if(unlikely(s->h->combining != NULL && s->h->combining != s))
+			/* Keep the chronological order of frames of different streams. */
+			check_res(rtc_combine_flush(s->h));
+
+		return rtc_combine(s, buffer, len);
+	}
+
+	if(unlikely(s->h->combining != NULL))
+		check_res(rtc_combine_flush(s->h));
+
+	return rtc_write_(s, buffer, len, more, false, !partial);
+}
+
+int rtc_flush(rtc_handle* h) {
+	if(!h)
+		return EINVAL;
+
+	check_res(rtc_combine_flush(h));
+	return h->param->write(h, NULL, 0, RTC_FLAG_FLUSH);
 }
 
 
@@ -809,19 +1243,33 @@ int rtc_start(rtc_handle* h, rtc_param const* param) {
 		return EINVAL;
 	if(!param->write)
 		return EINVAL;
+#ifdef RTC_Unit_SIZE
+	if(param->Unit != RTC_Unit_SIZE)
+		/* Fixed at compile time. */
+		return EINVAL;
+#else
 	if(param->Unit < RTC_MIN_UNIT_SIZE)
 		return EINVAL;
-	if(param->unit < RTC_MIN_UNIT_SIZE)
+	if(rtc_popcount(param->Unit) != 1)
 		return EINVAL;
-	if(param->Unit < param->unit)
+#endif
+#ifdef RTC_unit_SIZE
+	if(param->unit != RTC_unit_SIZE)
+		/* Fixed at compile time. */
 		return EINVAL;
-	if(rtc_popcount(param->Unit) != 1)
+#else
+	if(param->unit < RTC_MIN_UNIT_SIZE)
 		return EINVAL;
 	if(rtc_popcount(param->unit) != 1)
 		return EINVAL;
 	if(param->unit <= RTC_FRAME_MAX_SIZE)
 		/* A unit must be able to contain a Marker and Index. */
 		return EINVAL;
+#endif
+#if !defined(RTC_Unit_SIZE) || !defined(RTC_unit_SIZE)
+	if(param->Unit < param->unit)
+		return EINVAL;
+#endif
 
 	memset(h, 0, sizeof(*h));
 	h->param = param;
@@ -836,10 +1284,14 @@ int rtc_stop(rtc_handle* h) {
 	if(!h)
 		return EINVAL;
 
+	rtc_combine_flush(h);
+
+	if(h->cursor > 0) {
+		rtc_Dropped(h);
 #ifndef RTC_NO_CRC
-	if(h->cursor > 0)
 		rtc_Crc(h);
 #endif
+	}
 
 	h->param->write(h, NULL, 0, RTC_FLAG_STOP | RTC_FLAG_FLUSH);
 	return 0;
@@ -64,7 +64,8 @@ enum {
 	RTC_FLAG_START = 1,
 	RTC_FLAG_STOP = 2,
 	RTC_FLAG_NEW_UNIT = 4,
-	RTC_FLAG_FLUSH = 8
+	RTC_FLAG_FLUSH = 8,
+	RTC_FLAG_FRAME = 16
 };
 
 typedef unsigned char rtc_marker;
@@ -75,22 +76,59 @@ typedef unsigned char rtc_marker;
 struct rtc_handle;
 
 typedef int (rtc_write_callback)(struct rtc_handle* h, void const* buf, size_t len, int flags);
+typedef unsigned long (rtc_time_callback)(struct rtc_handle* h);
+typedef int (rtc_compare_callback)(void const* a, void const* b, size_t len);
 
 enum {
 	RTC_MIN_UNIT_SIZE = 64
 };
 
+/*
+ * Define RTC_Unit_SIZE and/or RTC_unit_SIZE while compiling rtc_writer.c to
+ * fix the Unit and unit sizes at compile time. The corresponding fields in
+ * #rtc_param must then be set to the same value, which is what
+ * #rtc_param_default() does.
+ */
+
 typedef struct rtc_param {
 	/*! \brief Size of Unit in bytes. Must be a power of 2. */
 	size_t Unit;
 	/*! \brief Size of unit in bytes. Must be a power of 2. */
 	size_t unit;
-	/*! \brief Callback to receive frame data. */
+	/*!
+	 * \brief Callback to receive frame data.
+	 *
+	 * Return 0 when all data is accepted. A call with #RTC_FLAG_FRAME
+	 * passes the header of a data frame, of which the payload of at most
+	 * #RTC_MARKER_BLOCK bytes follows in the next call. The callback may
+	 * refuse the frame as a whole by returning \c EAGAIN for the header,
+	 * and the writer then drops that frame and remains consistent. Any
+	 * other error, or \c EAGAIN for any other call, leaves the RTC in an
+	 * undefined state.
+	 */
 	rtc_write_callback* write;
 	/*! \brief User-defined value. */
 	void* arg;
+	/*!
+	 * \brief Monotonic time in application-defined ticks.
+	 *
+	 * Only used for #RTC_LIMIT_BUCKET. If \c NULL, one tick is one unit
+	 * of trace data.
+	 */
+	rtc_time_callback* time;
 } rtc_param;
 
+enum {
+	/*! \brief Emit all frames. */
+	RTC_LIMIT_NONE = 0,
+	/*! \brief Token bucket of \c limit_n payload bytes per tick, up to \c limit_burst bytes. */
+	RTC_LIMIT_BUCKET,
+	/*! \brief Emit only every \c limit_n-th frame. */
+	RTC_LIMIT_DECIMATE,
+	/*! \brief Emit only the minimum and maximum of every \c limit_n frames. */
+	RTC_LIMIT_MINMAX
+};
+
 #define RTC_STREAM_VARIABLE_LENGTH ((size_t)-1)
 
 typedef struct rtc_stream_param {
@@ -119,6 +157,66 @@ typedef struct rtc_stream_param {
 	 * Should be \c false for normal streams.
 	 */
 	bool hidden;
+
+	/*!
+	 * \brief Buffer to combine consecutive small writes into one frame.
+	 *
+	 * Only use this for \c cont streams, as frame boundaries are not
+	 * preserved. Pending data is written when the buffer is full, when
+	 * another stream is written (which preserves the chronological order
+	 * of all frames), and by #rtc_flush() and #rtc_stop().
+	 *
+	 * Set to \c NULL to write every #rtc_write() as a separate frame.
+	 */
+	void* combine_buffer;
+
+	/*! \brief Size of \c combine_buffer in bytes. */
+	size_t combine_size;
+
+	/*!
+	 * \brief Buffer to hold the last emitted value of a state-like stream.
+	 *
+	 * When set, #rtc_write() drops a frame when its payload equals the
+	 * previous one. The value is still emitted once per Unit, such that a
+	 * reader that starts at any Marker will find the current state.
+	 * Frames that are larger than \c state_size are always emitted.
+	 *
+	 * Set to \c NULL to emit all frames.
+	 */
+	void* state_buffer;
+
+	/*! \brief Size of \c state_buffer in bytes. */
+	size_t state_size;
+
+	/*!
+	 * \brief Policy to limit the amount of trace data of this stream.
+	 *
+	 * One of \c RTC_LIMIT_*. Frames that are dropped because of this
+	 * policy are counted in \c dropped_frames and \c dropped_bytes of the
+	 * #rtc_stream, and reported once per Unit in the \c Dropped stream.
+	 */
+	int limit;
+
+	/*! \brief Rate of #RTC_LIMIT_BUCKET, or the window of #RTC_LIMIT_DECIMATE and #RTC_LIMIT_MINMAX. */
+	size_t limit_n;
+
+	/*! \brief Capacity of the bucket of #RTC_LIMIT_BUCKET. If 0, \c limit_n is used. */
+	size_t limit_burst;
+
+	/*!
+	 * \brief Comparison of two frames for #RTC_LIMIT_MINMAX.
+	 *
+	 * Return a value less than, equal to, or greater than 0, like \c memcmp().
+	 */
+	rtc_compare_callback* limit_compare;
+
+	/*!
+	 * \brief Buffer of #RTC_LIMIT_MINMAX for two frames.
+	 *
+	 * Must be at least \c frame_length * 2 bytes. The stream must have a
+	 * fixed length.
+	 */
+	void* limit_buffer;
 } rtc_stream_param;
 
 typedef struct rtc_stream {
@@ -130,7 +228,23 @@ typedef struct rtc_stream {
 	size_t id_str_len;
 	size_t param_json_len;
 	bool used;
+	bool more;
 	rtc_offset index;
+	size_t combine_len;
+	size_t state_len;
+	rtc_offset state_Unit_end;
+	bool drop;
+	size_t limit_tokens;
+	unsigned long limit_time;
+	size_t limit_count;
+	size_t limit_min;
+	size_t limit_max;
+	/*! \brief Number of frames that were dropped by a limit or a full sink. */
+	rtc_offset dropped_frames;
+	/*! \brief Number of payload bytes that were dropped by a limit or a full sink. */
+	rtc_offset dropped_bytes;
+	rtc_offset reported_frames;
+	rtc_offset reported_bytes;
 	struct rtc_stream* next;
 	struct rtc_stream* prev;
 } rtc_stream;
@@ -154,6 +268,8 @@ typedef struct rtc_handle {
 	struct rtc_stream* first_stream;
 	struct rtc_stream* last_stream;
 	unsigned int free_id;
+	struct rtc_stream* combining;
+	struct rtc_stream dropped;
 	rtc_offset cursor;
 	rtc_offset Unit_count;
 	bool meta_changed;
@@ -249,6 +365,9 @@ int rtc_close(rtc_stream* s); /* may return that it cannot delete it yet */
  *             Make sure to call #rtc_write() the last time with \p more set to \c false.
  * \return 0 on success, otherwise an errno. If an error is returned, the RTC
  *         may be left in an undefined state. Advice to #rtc_stop() and restart.
+ *         When the write callback refuses a frame with \c EAGAIN, the frame
+ *         is dropped, counted in \c dropped_frames and \c dropped_bytes of
+ *         \p s, and 0 is returned.
  */
 int rtc_write(rtc_stream* s, void const* buffer, size_t len, bool more
 #ifdef __cplusplus
@@ -256,6 +375,18 @@ int rtc_write(rtc_stream* s, void const* buffer, size_t len, bool more
 #endif
 	);
 
+/*!
+ * \brief Write pending combined data of all streams.
+ *
+ * Call this periodically, e.g. from a timer, to bound the latency of streams
+ * that use \c combine_buffer. Afterwards, the write callback is called with
+ * #RTC_FLAG_FLUSH.
+ *
+ * \param h the RTC, should be opened
+ * \return 0 on success, otherwise an errno.
+ */
+int rtc_flush(rtc_handle* h);
+
 #ifndef RTC_NO_CRC
 /*!
  * \brief Initialize a new CRC value.